@@ -8,6 +8,9 @@
 #define BOUNCER_AMOUNT 5
 #define TRAIL_LENGTH 10
 #define TRAIL_CHECK_MS 0
+#define EVENT_BUFFER_SIZE 256 // must be a power of 2
+#define EVENT_BATCH_SIZE 64
+#define EVENT_LOG_FILE "events.log"
 
 // scaling
 float scale;
@@ -74,6 +77,25 @@ typedef struct {
     double v;       // a fraction between 0 and 1
 } hsv;
 
+// gameplay events, recorded for offline analysis
+typedef enum {
+    EVENT_BOUNCER_HIT,
+    EVENT_FLIPPER_CONTACT,
+    EVENT_BORDER_BOUNCE,
+    EVENT_DRAIN,
+    EVENT_STREAK_END
+} EventType;
+
+// written to the log as-is, so the fields are ordered to avoid padding (24 bytes)
+typedef struct {
+    Vector position;      // ball position
+    Vector velocity;      // ball velocity after the event
+    unsigned int time;    // ms since the game started
+    unsigned short value; // points for bouncer hits, lives left for drains, streak length for streak ends
+    unsigned char type;   // an EventType
+    unsigned char index;  // which bouncer, flipper (0 = left) or border segment, otherwise 0
+} GameEvent;
+
 
 // physics scene
 bool paused = false;
@@ -98,6 +120,14 @@ int trailIndex = 0;
 unsigned long lastTrailUpdate = 0;
 int latestColor;
 
+// event ring buffer, the game pushes to the head and flushEvents drains from the tail
+// only used from the main loop, don't push events from timer callbacks
+GameEvent events[EVENT_BUFFER_SIZE];
+unsigned int eventHead = 0;
+unsigned int eventTail = 0;
+unsigned int eventTime = 0; // updated once per frame, so pushing doesn't call clock()
+FILE* eventLog = NULL;
+
 // general util functions
 float clamp(float n, float start, float end) {
     return MAX(start, MIN(end, n));
@@ -218,6 +248,66 @@ rgb hsv2rgb(hsv in)
     return out;     
 }
 
+// event recording
+// called from the physics code, so no allocation or stdio in here
+void pushEvent(EventType type, int index, int value, Ball* ball) {
+    unsigned int head = eventHead;
+    // flushed every frame, so this shouldn't fill up, but drop the event rather than overwrite one
+    if (head - eventTail >= EVENT_BUFFER_SIZE) {
+        return;
+    }
+
+    GameEvent* event = &events[head & (EVENT_BUFFER_SIZE - 1)];
+    event->position = ball->position;
+    event->velocity = ball->velocity;
+    event->time = eventTime;
+    event->value = (unsigned short)value;
+    event->type = (unsigned char)type;
+    event->index = (unsigned char)index;
+
+    eventHead = head + 1;
+}
+
+void openEventLog() {
+    // append, so earlier sessions are kept
+    eventLog = fopen(EVENT_LOG_FILE, "ab");
+    if (eventLog == NULL) {
+        return;
+    }
+    // each session starts with a header: magic, format version, record size
+    unsigned char header[8] = {'W', 'B', 'E', 'V', 1, 0, sizeof(GameEvent), 0};
+    fwrite(header, 1, sizeof(header), eventLog);
+}
+
+// write buffered events to the log once there's a full batch (or always, if force is set)
+void flushEvents(bool force) {
+    unsigned int tail = eventTail;
+    unsigned int count = eventHead - tail;
+    if (count == 0 || (count < EVENT_BATCH_SIZE && !force)) {
+        return;
+    }
+
+    if (eventLog != NULL) {
+        unsigned int start = tail & (EVENT_BUFFER_SIZE - 1);
+        // the batch may wrap around the end of the buffer, so write it in up to two chunks
+        unsigned int firstChunk = MIN(count, EVENT_BUFFER_SIZE - start);
+        fwrite(&events[start], sizeof(GameEvent), firstChunk, eventLog);
+        if (firstChunk < count) {
+            fwrite(&events[0], sizeof(GameEvent), count - firstChunk, eventLog);
+        }
+    }
+
+    eventTail = tail + count;
+}
+
+void closeEventLog() {
+    flushEvents(true);
+    if (eventLog != NULL) {
+        fclose(eventLog);
+        eventLog = NULL;
+    }
+}
+
 // feature-specific functions
 void updateBall(Ball* b, float dt) {
     b->velocity.y += gravity * dt;
@@ -225,13 +315,14 @@ void updateBall(Ball* b, float dt) {
     b->position.y += b->velocity.y * dt;
 
     if (b->position.y < deathZone) {
-        printf("test!!!!");
+        lives--;
+        pushEvent(EVENT_DRAIN, 0, lives, b);
         b->position = (Vector){0.8, 0.7};
         b->velocity = (Vector){0, 0}; 
-        lives--;
     }
 
-    if (b->position.y < streakEndZone) {
+    if (b->position.y < streakEndZone && streak > 0) {
+        pushEvent(EVENT_STREAK_END, 0, streak, b);
         streak = 0;
     }
 }
@@ -247,14 +338,15 @@ void updateFlipper(Flipper* flipper, float dt, bool pressed) {
 
 
 // collision handlers
-void handleBouncerCollision(Ball* ball, Bouncer* bouncer) {
+void handleBouncerCollision(Ball* ball, Bouncer* bouncer, int index) {
     Vector directionVector = subtractVectors(ball->position, bouncer->position); // vector pointing from the ball center to the bouncer center
     float distance = vectorLength(directionVector);
     // if the distance is greater than the sum of the radii, they aren't touching
     if (distance > ball->radius + bouncer->radius || distance == 0) { return; }
     
     // add to score
-    score += bouncer->score * (1 + streak/10);
+    int points = bouncer->score * (1 + streak/10);
+    score += points;
     streak++;
     // trigger bouncer hit effects
     bouncer->hitTimer = 5;
@@ -269,6 +361,8 @@ void handleBouncerCollision(Ball* ball, Bouncer* bouncer) {
     // add the new velocity to the ball (away from the bouncer)
     float velocityTowardsBouncer = dotProduct(ball->velocity, directionVector); // the component of the ball's velocity in the bouncer's direction
     ball->velocity = addVectors(ball->velocity, scaleVector(directionVector, bouncer->pushStrength - velocityTowardsBouncer));
+
+    pushEvent(EVENT_BOUNCER_HIT, index, points, ball);
 }
 void handleFlipperCollision(Ball* ball, Flipper* flipper) {
     Vector tip = getFlipperTip(flipper);
@@ -280,7 +374,10 @@ void handleFlipperCollision(Ball* ball, Flipper* flipper) {
         return;
 
     // reset streak
-    streak = 0;
+    if (streak > 0) {
+        pushEvent(EVENT_STREAK_END, 0, streak, ball);
+        streak = 0;
+    }
 
     directionVector = scaleVector(directionVector, 1.0 / d);
 
@@ -297,6 +394,8 @@ void handleFlipperCollision(Ball* ball, Flipper* flipper) {
     float vnew = dotProduct(surfaceVel, directionVector);
 
     ball->velocity = addVectors(ball->velocity, scaleVector(directionVector, vnew - v));
+
+    pushEvent(EVENT_FLIPPER_CONTACT, flipper->sign > 0 ? 0 : 1, 0, ball);
 }
 
 void handleBorderCollision(Ball* ball, Vector border[], int borderCount) {
@@ -353,6 +452,8 @@ void handleBorderCollision(Ball* ball, Vector border[], int borderCount) {
     
     float energyLoss = 0.8f; 
     ball->velocity = scaleVector(reflectedVelocity, energyLoss);
+
+    pushEvent(EVENT_BORDER_BOUNCE, closestIndex, 0, ball);
 }
 
 
@@ -484,6 +585,8 @@ int main(int argc, const char **argv)
     
     buffer = create_bitmap(SCREEN_W, SCREEN_H);
 
+    openEventLog();
+
     // for filling in over the dark background
     int white_area[BORDER_POINTS * 2];
     for (int i = 0; i < BORDER_POINTS; i++) {
@@ -493,6 +596,8 @@ int main(int argc, const char **argv)
     
     while (1) {
 
+        eventTime = clock() * 1000 / CLOCKS_PER_SEC;
+
         new_time = (double)retrace_count / CLOCKS_PER_SEC;
         dt = new_time - old_time;
         dt = MIN(dt, 1.0/60.0);
@@ -623,6 +728,7 @@ int main(int argc, const char **argv)
         updateBall(&ball, dt);
         // end game if lives are 0
         if (lives == 0) {
+            closeEventLog();
             allegro_exit();
             printf("Thanks for playing! You got: %d", score);
             return 0;
@@ -630,7 +736,7 @@ int main(int argc, const char **argv)
 
         // ball interactions
         for (int i = 0; i < BOUNCER_AMOUNT; i++) {
-            handleBouncerCollision(&ball,  &bouncers[i]);
+            handleBouncerCollision(&ball,  &bouncers[i], i);
         }
         for (int i = 0; i < 2; i++) {
             handleFlipperCollision(&ball, &flippers[i]);
@@ -639,6 +745,9 @@ int main(int argc, const char **argv)
 
         updateTrail(&ball);
 
+        // write out gameplay events in batches
+        flushEvents(false);
+
         vsync();
         blit(buffer, screen, 0, 0, 0, 0, SCREEN_W, SCREEN_H);
 
@@ -647,6 +756,7 @@ int main(int argc, const char **argv)
         }
 
         if (key[KEY_ESC] || (key[KEY_LCONTROL] && key[KEY_C])) {
+            closeEventLog();
             allegro_exit();
             return 0;
         }